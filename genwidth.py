@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+# Generates widthtables.h, the zero width and double width tables used by utf8Width() in myEdit.c
+# Run: python3 genwidth.py > widthtables.h
+# Data comes from python's unicodedata module, which has same data as UnicodeData.txt and EastAsianWidth.txt
+
+import sys
+import unicodedata
+
+MAX_CP = 0x10FFFF
+
+# code points not assigned yet are wide in these blocks (default values of EastAsianWidth.txt)
+WIDE_DEFAULTS = [(0x3400, 0x4DBF), (0x4E00, 0x9FFF), (0xF900, 0xFAFF),
+                 (0x20000, 0x2FFFD), (0x30000, 0x3FFFD)]
+
+def is_zero_width(cp):
+    if cp == 0x00AD:                    # soft hyphen is drawn by terminals
+        return False
+    if 0x1160 <= cp <= 0x11FF:          # hangul medial vowels and final consonants join with the char before
+        return True
+    if cp == 0x200B:                    # zero width space
+        return True
+    return unicodedata.category(chr(cp)) in ("Mn", "Me", "Cf")
+
+def is_double_width(cp):
+    if unicodedata.east_asian_width(chr(cp)) in ("W", "F"):
+        return True
+    return any(first <= cp <= last for first, last in WIDE_DEFAULTS) and unicodedata.category(chr(cp)) == "Cn"
+
+def ranges(pred):
+    out = []
+    start = None
+    for cp in range(MAX_CP + 2):
+        hit = cp <= MAX_CP and not (0xD800 <= cp <= 0xDFFF) and pred(cp)
+        if hit and start is None:
+            start = cp
+        elif not hit and start is not None:
+            out.append((start, cp - 1))
+            start = None
+    return out
+
+def emit(name, comment, table):
+    print("static const struct widthRange %s[] = {\t// %s" % (name, comment))
+    for i in range(0, len(table), 4):
+        row = ", ".join("{0x%04X, 0x%04X}" % r for r in table[i:i + 4])
+        print("\t%s%s" % (row, "," if i + 4 < len(table) else ""))
+    print("};")
+
+zero = ranges(is_zero_width)
+double = ranges(lambda cp: not is_zero_width(cp) and is_double_width(cp))
+
+print("/* generated by genwidth.py from unicode %s, do not edit */" % unicodedata.unidata_version)
+print()
+emit("zeroWidth", "combining marks (Mn, Me) and format chars (Cf), they are drawn on top of previous char", zero)
+print()
+emit("doubleWidth", "east asian wide (W) and fullwidth (F) chars take two columns", double)
@@ -11,10 +11,25 @@
 #include <fcntl.h>	// open(), O_RDWR, and O_CREAT etc also
 #include <sys/types.h>	// for ssize_t data type (sizeof(ssize_t) is greater or = sizeof(int))
 #include <string.h>
+#include <stdarg.h>	// va_list for editorSetStatusMessage()
+#include <time.h>	// status message disappears after some seconds
 #include <termios.h>
 #include <errno.h>
 #include <sys/ioctl.h> 	// for window size easy way
 #include <unistd.h>	// ftruncate() and close() etc
+#include <signal.h>	// ignoring SIGPIPE while filtering
+#include <poll.h>
+#include <sys/uio.h>	// writev() for writing many rows in one call
+#include <sys/wait.h>
+#include <stdint.h>	// uint64_t for checking 8 bytes at a time
+#ifdef __SSE2__
+#include <emmintrin.h>	// SSE2 for checking 16 bytes at a time
+#endif
+#include <pthread.h>	// compressed files are loaded on a second thread
+#include <zlib.h>	// gzip files
+#ifdef HAVE_ZSTD
+#include <zstd.h>	// zstd files, only when libzstd is installed (see Makefile)
+#endif
 
 
 /**** defines ****/
@@ -22,6 +37,8 @@
 # define CTRL_KEY(k) ((k) & 0x1f) // will AND the key we entered(along with Ctrl) with 0x1f(00011111).
 #define EDITOR_VERSION "0.1"
 #define EDITOR_TAB_STOP 8
+#define EDITOR_CHUNK (64 * 1024)	// bytes decompressed at a time, file is never decompressed as a whole
+#define EDITOR_IOV 512			// max rows + newlines sent to filter command in one writev()
 
 enum editorKey {
 	BACKSPACE = 127,
@@ -36,11 +53,18 @@ enum editorKey {
   	PAGE_DOWN
 };
 
+enum editorCompress {		// format of file on disk, file is saved back in same format
+	COMPRESS_NONE = 0,
+	COMPRESS_GZIP,
+	COMPRESS_ZSTD
+};
+
 /*** data ****/
 
 typedef struct erow {			// for storing a row of characters
 	int size;
 	int rsize;			// for rendering tab, removing tab error in our editor
+	int ascii;			// 1 if chars has no byte >= 128, then every byte is one column and the utf-8 code is skipped
 	char *chars;
 	char *render;			// rendering chars for removing tab error, previously in our editor tab was filled by initial chars of that line
 } erow;
@@ -56,13 +80,46 @@ struct editorConfig			// editor's global state
 	int numrows;			// for number of rows	
 	erow *row;
 	char *filename;
+	int compress;			// enum editorCompress
+	char statusmsg[256];		// message shown in last line of screen
+	time_t statusmsg_time;		// when message was set
+	char *prompt;			// while editorPrompt() runs, last line shows prompt and promptbuf instead of message
+	char *promptbuf;
 	struct termios orig_termios;
 };
 
 struct editorConfig E;
 
+struct rowBuilder {			// splits a stream of bytes into rows
+	erow *rows;			// complete rows
+	int numrows;
+	int cap;
+	char *line;			// last line which is not complete yet
+	size_t linelen;
+	size_t linecap;
+};
+
+struct editorLoader {			// state shared with the thread that loads compressed files
+	pthread_t thread;
+	pthread_mutex_t lock;		// protects rows, numrows and done
+	pthread_cond_t ready;		// signalled when new rows are handed over or loading is done
+	int active;			// thread is started and not joined yet
+	int done;
+	int failed;			// corrupt or truncated file
+	int fd;
+	int compress;
+	erow *rows;			// rows loaded by the thread but not moved to E.row yet
+	int numrows;
+};
+
+struct editorLoader L;
+
 void editorRefreshScreen();
 char *editorPrompt(char *prompt);
+void editorSetStatusMessage(const char *fmt, ...);
+int editorLoadPoll();
+void editorLoadWaitAtEnd();
+int editorLastCy();
 
 /*** terminal ****/
 
@@ -108,6 +165,8 @@ int editorReadKey()
 	{
 		if (nread == -1 && errno != EAGAIN)
 			die("Error in reading character");
+		if (editorLoadPoll())		// while we wait for a key, show rows loaded in background
+			editorRefreshScreen();
 	}
 							// when ever we press an arrow keys then it write 3 characters \x1b, [ and A/B/C/D
 	if (c == '\x1b') {				// after reading escape character in c we read two more characters in seq
@@ -150,7 +209,7 @@ int editorReadKey()
 			// why return '\x1b'? it will run while loop in main() again for refreshing and for processkey.
 	  return '\x1b';			// if not A/B/C/D/5/6 then we assume the user just pressed the Escape key and return that
 	} else {
-	  return c;
+	  return (unsigned char)c;	// bytes of utf-8 chars are >= 128, don't let them become negative
 	}
 }
 
@@ -196,19 +255,175 @@ int getWindowSize(int *rows, int *cols)				// used to get the size of window row
 	}
 }
 
+/*** utf-8 ***/
+
+struct widthRange {			// inclusive range of code points
+	uint32_t first, last;
+};
+
+#include "widthtables.h"		// zeroWidth[] and doubleWidth[], generated by genwidth.py
+
+static const unsigned char utf8SeqLen[16] = {	// indexed by high 4 bits of first byte, 0 means continuation byte(invalid as first byte)
+	1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 2, 2, 3, 4
+};
+
+static const uint32_t utf8MinCp[5] = { 0, 0, 0x80, 0x800, 0x10000 };	// smallest code point for each length, smaller ones are overlong
+
+#define UTF8_IS_CONT(c) (((unsigned char)(c) & 0xC0) == 0x80)	// 10xxxxxx is a continuation byte
+
+int isAsciiBuf(const char *s, int len) {	// checks the high bit of many bytes at once instead of one by one
+	int j = 0;
+#ifdef __SSE2__
+	for (; j + 16 <= len; j += 16)
+		if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)&s[j])))	// movemask collects the high bit of all 16 bytes
+			return 0;
+#endif
+	for (; j + 8 <= len; j += 8) {
+		uint64_t w;
+		memcpy(&w, &s[j], 8);
+		if (w & 0x8080808080808080ULL) return 0;
+	}
+	for (; j < len; j++)
+		if ((unsigned char)s[j] & 0x80) return 0;
+	return 1;
+}
+
+int utf8Decode(const char *s, int len, uint32_t *cp) {	// returns no of bytes of char at s, invalid bytes are returned as 1 byte with *cp = 0xFFFD
+	unsigned char c = s[0];
+	int n = utf8SeqLen[c >> 4];
+	if (n == 1) {
+		*cp = c;
+		return 1;
+	}
+	if (n == 0 || n > len || (c >= 0xF8)) {
+		*cp = 0xFFFD;
+		return 1;
+	}
+	uint32_t v = c & (0x7F >> n);		// payload bits of first byte
+	int j;
+	for (j = 1; j < n; j++) {
+		if (!UTF8_IS_CONT(s[j])) {
+			*cp = 0xFFFD;
+			return 1;
+		}
+		v = (v << 6) | (s[j] & 0x3F);
+	}
+	if (v < utf8MinCp[n] || v > 0x10FFFF || (v >= 0xD800 && v <= 0xDFFF)) {	// overlong, out of range or surrogate
+		*cp = 0xFFFD;
+		return 1;
+	}
+	*cp = v;
+	return n;
+}
+
+int inWidthTable(uint32_t cp, const struct widthRange *t, int n) {	// binary search in sorted ranges
+	int lo = 0, hi = n - 1;
+	if (cp < t[0].first || cp > t[n - 1].last) return 0;
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		if (cp > t[mid].last) lo = mid + 1;
+		else if (cp < t[mid].first) hi = mid - 1;
+		else return 1;
+	}
+	return 0;
+}
+
+int utf8Width(uint32_t cp) {		// no of terminal columns taken by a code point
+	if (cp < 0x300) return 1;	// latin chars, nothing to look up
+	if (inWidthTable(cp, zeroWidth, sizeof(zeroWidth) / sizeof(zeroWidth[0]))) return 0;
+	if (inWidthTable(cp, doubleWidth, sizeof(doubleWidth) / sizeof(doubleWidth[0]))) return 2;
+	return 1;
+}
+
+int utf8StrWidth(const char *s, int len) {	// no of columns taken by s
+	int width = 0;
+	int j = 0;
+	while (j < len) {
+		uint32_t cp;
+		j += utf8Decode(&s[j], len - j, &cp);
+		width += utf8Width(cp);
+	}
+	return width;
+}
+
 /*** row operations ***/
 
 int editorRowCxToRx(erow *row, int cx) {	// getting proper tab position to move
   	int rx = 0;
   	int j;
-  	for (j = 0; j < cx; j++) {
-    		if (row->chars[j] == '\t')
-      			rx += (EDITOR_TAB_STOP - 1) - (rx % EDITOR_TAB_STOP);
-    		rx++;
+  	if (row->ascii) {			// every byte is one column
+  		for (j = 0; j < cx; j++) {
+    			if (row->chars[j] == '\t')
+      				rx += (EDITOR_TAB_STOP - 1) - (rx % EDITOR_TAB_STOP);
+    			rx++;
+  		}
+  		return rx;
+  	}
+  	j = 0;
+  	while (j < cx) {
+  		if (row->chars[j] == '\t') {
+  			rx += EDITOR_TAB_STOP - (rx % EDITOR_TAB_STOP);
+  			j++;
+  		} else {
+  			uint32_t cp;
+  			j += utf8Decode(&row->chars[j], row->size - j, &cp);
+  			rx += utf8Width(cp);
+  		}
   	}
   	return rx;
 }
 
+int editorRowNextCx(erow *row, int cx) {	// byte index of next char, combining marks are kept with the char before them
+	if (cx >= row->size) return row->size;
+	if (row->ascii) return cx + 1;
+	uint32_t cp;
+	cx += utf8Decode(&row->chars[cx], row->size - cx, &cp);
+	while (cx < row->size) {
+		int n = utf8Decode(&row->chars[cx], row->size - cx, &cp);
+		if (utf8Width(cp) != 0) break;
+		cx += n;
+	}
+	return cx;
+}
+
+int editorRowPrevCx(erow *row, int cx) {	// byte index of previous char, opposite of editorRowNextCx()
+	if (cx <= 0) return 0;
+	if (row->ascii) return cx - 1;
+	while (cx > 0) {
+		int j = cx - 1;
+		while (j > 0 && cx - j < 4 && UTF8_IS_CONT(row->chars[j])) j--;	// go back to first byte of sequence
+		uint32_t cp;
+		if (j + utf8Decode(&row->chars[j], row->size - j, &cp) != cx) {	// invalid byte, step one byte only
+			j = cx - 1;
+			cp = 0xFFFD;
+		}
+		cx = j;
+		if (utf8Width(cp) != 0) break;	// stop at a char which takes space
+	}
+	return cx;
+}
+
+int editorRowRxToCx(erow *row, int rx) {	// opposite of editorRowCxToRx(), gives start of char which is drawn at column rx
+	int cur_rx = 0;
+	int cx = 0;
+	while (cx < row->size) {
+		int w;
+		if (row->chars[cx] == '\t') {
+			w = EDITOR_TAB_STOP - (cur_rx % EDITOR_TAB_STOP);
+		} else if (row->ascii) {
+			w = 1;
+		} else {
+			uint32_t cp;
+			utf8Decode(&row->chars[cx], row->size - cx, &cp);
+			w = utf8Width(cp);
+		}
+		if (cur_rx + w > rx) return cx;
+		cur_rx += w;
+		cx = editorRowNextCx(row, cx);
+	}
+	return cx;
+}
+
 void editorUpdateRow(erow *row) {		// here we are copying all rows int row->render
 	int tabs = 0;  	
 	int j;	
@@ -217,16 +432,42 @@ void editorUpdateRow(erow *row) {		// here we are copying all rows int row->rend
 
 	free(row->render);
 	row->render = malloc(row->size + tabs*(EDITOR_TAB_STOP - 1) + 1);
+	row->ascii = isAsciiBuf(row->chars, row->size);
   	
   	int idx = 0;
-  	for (j = 0; j < row->size; j++) {
-    		if (row->chars[j] == '\t') {
-      			row->render[idx++] = ' ';
-      			while (idx % EDITOR_TAB_STOP != 0) row->render[idx++] = ' ';	// copy blank space at upto 8 places if '\t' in line.
-    		} else {
-  			row->render[idx++] = row->chars[j];	// copying chars from row->chars to row->render	
-		  }  	
-	}
+  	if (row->ascii) {
+  		for (j = 0; j < row->size; j++) {
+    			if (row->chars[j] == '\t') {
+      				row->render[idx++] = ' ';
+      				while (idx % EDITOR_TAB_STOP != 0) row->render[idx++] = ' ';	// copy blank space at upto 8 places if '\t' in line.
+    			} else {
+  				row->render[idx++] = row->chars[j];	// copying chars from row->chars to row->render	
+			  }  	
+		}
+  	} else {
+  		int col = 0;			// here bytes and columns are not same, so tab stops are counted in columns
+  		j = 0;
+  		while (j < row->size) {
+  			if (row->chars[j] == '\t') {
+  				do {
+  					row->render[idx++] = ' ';
+  					col++;
+  				} while (col % EDITOR_TAB_STOP != 0);
+  				j++;
+  				continue;
+  			}
+  			uint32_t cp;
+  			int n = utf8Decode(&row->chars[j], row->size - j, &cp);
+  			if (cp == 0xFFFD && n == 1)
+  				row->render[idx++] = '?';	// invalid byte, draw ? so the terminal doesn't get a broken sequence
+  			else {
+  				memcpy(&row->render[idx], &row->chars[j], n);
+  				idx += n;
+  			}
+  			col += utf8Width(cp);
+  			j += n;
+  		}
+  	}
   	row->render[idx] = '\0';
   	row->rsize = idx;				// no of chars copied to render
 }
@@ -296,17 +537,20 @@ void editorRowAppendString(erow *row, char *s, size_t len) {
   	editorUpdateRow(row);
 }
 
-void editorRowDelChar(erow *row, int at) {
+void editorRowDelChar(erow *row, int at, int len) {	// len is no of bytes, a utf-8 char can be upto 4 bytes
   	if (at < 0 || at >= row->size) return;	
+  	if (len > row->size - at) len = row->size - at;
 
-  	memmove(&row->chars[at], &row->chars[at + 1], row->size - at);	// memmove() is same like memcpy but it is more reliable then memcpy()
-  	row->size--;
+  	memmove(&row->chars[at], &row->chars[at + len], row->size - at - len + 1);	// memmove() is same like memcpy but it is more reliable then memcpy()
+  	row->size -= len;
   	editorUpdateRow(row);
 }
 
 /*** editor operations ***/
 
 void editorInsertChar(int c) {
+  	if (E.cy == E.numrows)
+  		editorLoadWaitAtEnd();
   	if (E.cy == E.numrows) {
     		editorInsertRow(E.numrows, "", 0);
   	}
@@ -315,6 +559,7 @@ void editorInsertChar(int c) {
 }
 
 void editorInsertNewline() {
+	editorLoadWaitAtEnd();		// new row can be added at end of file
   	if (E.cx == 0) {
     		editorInsertRow(E.cy, "", 0);
   	} else {
@@ -336,8 +581,9 @@ void editorDelChar() {	// delete character
 
   	erow *row = &E.row[E.cy];
   	if (E.cx > 0) {
-    		editorRowDelChar(row, E.cx - 1);	// E.cx is cursor position, E.cx-1 is character(right before cursor position) which will be deleted
-    		E.cx--;
+    		int prev = editorRowPrevCx(row, E.cx);	// E.cx is cursor position, prev is start of character(right before cursor position) which will be deleted
+    		editorRowDelChar(row, prev, E.cx - prev);
+    		E.cx = prev;
   	} else {
     		E.cx = E.row[E.cy - 1].size;
     		editorRowAppendString(&E.row[E.cy - 1], row->chars, row->size); // will send & of previeus row where our cursor is going after backspace, and churrent row's all chars and its size.
@@ -346,6 +592,219 @@ void editorDelChar() {	// delete character
 	  }
 }
 
+/*** background loading ***/
+
+void rbAddRow(struct rowBuilder *rb, const char *s, size_t len) {
+	while (len > 0 && s[len - 1] == '\r')	// remove \r of files saved on windows
+		len--;
+	if (rb->numrows == rb->cap) {
+		rb->cap = rb->cap ? rb->cap * 2 : 64;
+		rb->rows = realloc(rb->rows, sizeof(erow) * rb->cap);
+	}
+	erow *row = &rb->rows[rb->numrows++];
+	row->size = len;
+	row->chars = malloc(len + 1);
+	memcpy(row->chars, s, len);
+	row->chars[len] = '\0';
+	row->rsize = 0;
+	row->render = NULL;
+	editorUpdateRow(row);
+}
+
+void rbLineAppend(struct rowBuilder *rb, const char *s, size_t len) {
+	if (rb->linelen + len > rb->linecap) {
+		rb->linecap = (rb->linelen + len) * 2;
+		rb->line = realloc(rb->line, rb->linecap);
+	}
+	memcpy(&rb->line[rb->linelen], s, len);
+	rb->linelen += len;
+}
+
+void rbFeed(struct rowBuilder *rb, const char *buf, size_t len) {	// buf can end in middle of a line, that part is kept for next call
+	while (len > 0) {
+		const char *nl = memchr(buf, '\n', len);
+		if (!nl) {
+			rbLineAppend(rb, buf, len);
+			return;
+		}
+		size_t n = nl - buf;
+		if (rb->linelen == 0) {		// whole line is in buf, copy it directly into the row
+			rbAddRow(rb, buf, n);
+		} else {
+			rbLineAppend(rb, buf, n);
+			rbAddRow(rb, rb->line, rb->linelen);
+			rb->linelen = 0;
+		}
+		buf += n + 1;
+		len -= n + 1;
+	}
+}
+
+void rbFinish(struct rowBuilder *rb) {	// last line of file may not have \n at end
+	if (rb->linelen > 0)
+		rbAddRow(rb, rb->line, rb->linelen);
+	free(rb->line);
+	rb->line = NULL;
+	rb->linelen = rb->linecap = 0;
+}
+
+void editorLoaderHandOff(struct rowBuilder *rb) {	// give rows to main thread, only erow structs are copied not the chars
+	if (rb->numrows == 0) return;
+	pthread_mutex_lock(&L.lock);
+	L.rows = realloc(L.rows, sizeof(erow) * (L.numrows + rb->numrows));
+	memcpy(&L.rows[L.numrows], rb->rows, sizeof(erow) * rb->numrows);
+	L.numrows += rb->numrows;
+	pthread_cond_signal(&L.ready);
+	pthread_mutex_unlock(&L.lock);
+	rb->numrows = 0;
+}
+
+int editorGzipLoad(int fd, struct rowBuilder *rb) {
+	gzFile gz = gzdopen(fd, "rb");
+	if (gz == NULL) {
+		close(fd);
+		return -1;
+	}
+	gzbuffer(gz, EDITOR_CHUNK);
+	char *buf = malloc(EDITOR_CHUNK);
+	int n, err;
+	while ((n = gzread(gz, buf, EDITOR_CHUNK)) > 0) {	// gzread also reads concatenated .gz files
+		rbFeed(rb, buf, n);
+		editorLoaderHandOff(rb);
+	}
+	gzerror(gz, &err);			// truncated file gives an error here
+	gzclose(gz);				// also closes fd
+	free(buf);
+	return (n < 0 || err != Z_OK) ? -1 : 0;
+}
+
+#ifdef HAVE_ZSTD
+int editorZstdLoad(int fd, struct rowBuilder *rb) {
+	ZSTD_DStream *ds = ZSTD_createDStream();
+	if (ds == NULL) {
+		close(fd);
+		return -1;
+	}
+	size_t insize = ZSTD_DStreamInSize();
+	size_t outsize = ZSTD_DStreamOutSize();
+	char *in = malloc(insize);
+	char *out = malloc(outsize);
+	size_t ret = 0;
+	ssize_t nread;
+	int failed = 0;
+
+	ZSTD_initDStream(ds);
+	while (!failed && (nread = read(fd, in, insize)) > 0) {
+		ZSTD_inBuffer input = { in, nread, 0 };
+		while (input.pos < input.size) {
+			ZSTD_outBuffer output = { out, outsize, 0 };
+			ret = ZSTD_decompressStream(ds, &output, &input);
+			if (ZSTD_isError(ret)) {
+				failed = 1;
+				break;
+			}
+			rbFeed(rb, out, output.pos);
+		}
+		editorLoaderHandOff(rb);
+	}
+	if (nread < 0 || ret != 0)		// ret is not 0 if last frame is not complete
+		failed = 1;
+
+	ZSTD_freeDStream(ds);
+	free(in);
+	free(out);
+	close(fd);
+	return failed ? -1 : 0;
+}
+#endif
+
+void *editorLoadThread(void *arg) {
+	(void)arg;
+	struct rowBuilder rb = {NULL, 0, 0, NULL, 0, 0};
+	int ret = -1;
+
+	if (L.compress == COMPRESS_GZIP)
+		ret = editorGzipLoad(L.fd, &rb);
+#ifdef HAVE_ZSTD
+	else if (L.compress == COMPRESS_ZSTD)
+		ret = editorZstdLoad(L.fd, &rb);
+#endif
+	rbFinish(&rb);
+	editorLoaderHandOff(&rb);
+	free(rb.rows);
+
+	pthread_mutex_lock(&L.lock);
+	L.done = 1;
+	L.failed = (ret == -1);
+	pthread_cond_signal(&L.ready);
+	pthread_mutex_unlock(&L.lock);
+	return NULL;
+}
+
+void editorLoadStart(int fd, int compress) {
+	L.fd = fd;
+	L.compress = compress;
+	L.done = 0;
+	L.failed = 0;
+	if (pthread_create(&L.thread, NULL, editorLoadThread, NULL) != 0)
+		die("pthread_create");
+	L.active = 1;
+}
+
+int editorLoadPoll() {			// move loaded rows to end of E.row, returns 1 if anything changed
+	if (!L.active) return 0;
+
+	pthread_mutex_lock(&L.lock);
+	erow *rows = L.rows;
+	int n = L.numrows;
+	int done = L.done;
+	L.rows = NULL;
+	L.numrows = 0;
+	pthread_mutex_unlock(&L.lock);
+
+	if (n > 0) {
+		E.row = realloc(E.row, sizeof(erow) * (E.numrows + n));
+		memcpy(&E.row[E.numrows], rows, sizeof(erow) * n);
+		E.numrows += n;
+	}
+	free(rows);
+
+	if (done) {
+		pthread_join(L.thread, NULL);
+		L.active = 0;
+		if (L.failed) {			// we don't have whole file, so don't let Ctrl+S overwrite it
+			editorSetStatusMessage("%s is damaged, %d lines loaded. Ctrl+S asks for a new name", E.filename, E.numrows);
+			free(E.filename);
+			E.filename = NULL;
+		}
+	}
+	return n > 0 || done;
+}
+
+void editorLoadWaitRows(int numrows) {	// wait until numrows rows are loaded or the whole file is loaded
+	while (L.active && E.numrows < numrows) {
+		pthread_mutex_lock(&L.lock);
+		while (L.numrows == 0 && !L.done)
+			pthread_cond_wait(&L.ready, &L.lock);
+		pthread_mutex_unlock(&L.lock);
+		editorLoadPoll();
+	}
+}
+
+void editorLoadWait() {
+	editorLoadWaitRows(INT32_MAX);
+}
+
+void editorLoadWaitAtEnd() {		// rows are loaded at end of E.row, so a row added by user there must wait for them
+	if (!L.active || E.cy < E.numrows - 1) return;
+	editorLoadWait();
+}
+
+int editorLastCy() {			// cursor can go one row past end of file, but not past last loaded row while loading
+	if (!L.active) return E.numrows;
+	return E.numrows > 0 ? E.numrows - 1 : 0;
+}
+
 /*** file i/o ***/
 
 char *editorRowsToString(int *buflen) { //it will converts our array of erow structs into a single string that is ready to be written out to a file.
@@ -366,12 +825,51 @@ char *editorRowsToString(int *buflen) { //it will converts our array of erow str
 	return buf;						// will return string back
 }
 
+int editorDetectCompress(int fd) {	// check magic bytes at start of file
+	unsigned char magic[4];
+	ssize_t n = pread(fd, magic, sizeof(magic), 0);
+	if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+		return COMPRESS_GZIP;
+	if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+		return COMPRESS_ZSTD;
+	return COMPRESS_NONE;
+}
+
+int editorCompressFromName(char *filename) {	// for new files, format is decided by extension
+	char *ext = strrchr(filename, '.');
+	if (ext && strcmp(ext, ".gz") == 0) return COMPRESS_GZIP;
+#ifdef HAVE_ZSTD
+	if (ext && strcmp(ext, ".zst") == 0) return COMPRESS_ZSTD;	// without zstd support .zst files are saved plain
+#endif
+	return COMPRESS_NONE;
+}
+
 void editorOpen(char *filename) {
 	free(E.filename);
 	E.filename = strdup(filename);	
 
-	FILE *fp = fopen(filename, "r");
-	  if (!fp) die("fopen");
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1) die("open");
+
+	E.compress = editorDetectCompress(fd);
+#ifndef HAVE_ZSTD
+	if (E.compress == COMPRESS_ZSTD) {	// start with empty buffer and no filename, so the file can't be overwritten
+		editorSetStatusMessage("Can't open %s: myEdit was built without zstd support", filename);
+		close(fd);
+		free(E.filename);
+		E.filename = NULL;
+		E.compress = COMPRESS_NONE;
+		return;
+	}
+#endif
+	if (E.compress != COMPRESS_NONE) {	// decompress on a second thread, we only wait for the first screen
+		editorLoadStart(fd, E.compress);
+		editorLoadWaitRows(E.screenrows);
+		return;
+	}
+
+	FILE *fp = fdopen(fd, "r");
+	  if (!fp) die("fdopen");
 
 	  char *line = NULL;			// initially store NULL to line
 	  size_t linecap = 0;			// line capacity is 0 initially
@@ -387,11 +885,123 @@ void editorOpen(char *filename) {
 	fclose(fp);
 }
 
+#ifdef HAVE_ZSTD
+struct zstdWriter {			// rows are collected in "in" and compressed one full buffer at a time
+	ZSTD_CCtx *cctx;
+	int fd;
+	char *in;
+	size_t inlen;
+	size_t insize;
+	char *out;
+	size_t outsize;
+};
+
+int editorZstdFlush(struct zstdWriter *zw, ZSTD_EndDirective mode) {	// compress all of zw->in, ZSTD_e_end also finishes the frame
+	ZSTD_inBuffer input = { zw->in, zw->inlen, 0 };
+	size_t remaining;
+	do {
+		ZSTD_outBuffer output = { zw->out, zw->outsize, 0 };
+		remaining = ZSTD_compressStream2(zw->cctx, &output, &input, mode);
+		if (ZSTD_isError(remaining)) return -1;
+		if (output.pos > 0 && write(zw->fd, zw->out, output.pos) != (ssize_t)output.pos) return -1;
+	} while (mode == ZSTD_e_end ? remaining != 0 : input.pos < input.size);
+	zw->inlen = 0;
+	return 0;
+}
+
+int editorZstdAppend(struct zstdWriter *zw, const char *s, size_t len) {
+	while (len > 0) {
+		size_t n = zw->insize - zw->inlen;
+		if (n > len) n = len;
+		memcpy(&zw->in[zw->inlen], s, n);
+		zw->inlen += n;
+		s += n;
+		len -= n;
+		if (zw->inlen == zw->insize && editorZstdFlush(zw, ZSTD_e_continue) == -1)
+			return -1;
+	}
+	return 0;
+}
+
+int editorZstdSave(int fd) {
+	struct zstdWriter zw;
+	zw.cctx = ZSTD_createCCtx();
+	if (zw.cctx == NULL) {
+		close(fd);
+		return -1;
+	}
+	zw.fd = fd;
+	zw.insize = ZSTD_CStreamInSize();
+	zw.inlen = 0;
+	zw.in = malloc(zw.insize);
+	zw.outsize = ZSTD_CStreamOutSize();
+	zw.out = malloc(zw.outsize);
+
+	int ret = 0;
+	int j;
+	for (j = 0; j < E.numrows && ret == 0; j++) {
+		ret = editorZstdAppend(&zw, E.row[j].chars, E.row[j].size);
+		if (ret == 0)
+			ret = editorZstdAppend(&zw, "\n", 1);
+	}
+	if (ret == 0)
+		ret = editorZstdFlush(&zw, ZSTD_e_end);	// compress what is left and end the frame
+	ZSTD_freeCCtx(zw.cctx);
+	free(zw.in);
+	free(zw.out);
+	close(fd);
+	return ret;
+}
+#endif
+
+int editorGzipSave(int fd) {
+	gzFile gz = gzdopen(fd, "wb");
+	if (gz == NULL) {
+		close(fd);
+		return -1;
+	}
+	int ret = 0;
+	int j;
+	for (j = 0; j < E.numrows && ret == 0; j++) {	// rows are written one by one, gzwrite compresses them in its own buffer
+		if (E.row[j].size > 0 && gzwrite(gz, E.row[j].chars, E.row[j].size) != E.row[j].size)
+			ret = -1;
+		else if (gzwrite(gz, "\n", 1) != 1)
+			ret = -1;
+	}
+	if (gzclose(gz) != Z_OK)		// also closes fd
+		ret = -1;
+	return ret;
+}
+
+int editorSaveCompressed() {		// compress rows directly into the file, no uncompressed copy is made
+	int (*save)(int fd) = NULL;
+	if (E.compress == COMPRESS_GZIP)
+		save = editorGzipSave;
+#ifdef HAVE_ZSTD
+	else if (E.compress == COMPRESS_ZSTD)
+		save = editorZstdSave;
+#endif
+	if (save == NULL) return -1;		// file is not touched if we can't write its format
+
+	int fd = open(E.filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd == -1) return -1;
+	return save(fd);
+}
+
 void editorSave() {
+	editorLoadWait();				// whole file must be loaded before we write it back
   	if (E.filename == NULL)	{			// If it’s a new file
-    		E.filename = editorPrompt("Save as: %s");
+    		E.filename = editorPrompt("Save as: ");
+    		if (E.filename == NULL) return;
+    		E.compress = editorCompressFromName(E.filename);
   	}	
 
+  	if (E.compress != COMPRESS_NONE) {
+  		if (editorSaveCompressed() == -1)
+  			editorSetStatusMessage("Can't save %s", E.filename);
+  		return;
+  	}
+
   	int len;
   	char *buf = editorRowsToString(&len);
 
@@ -411,6 +1021,215 @@ void editorSave() {
 }
 
 
+/*** filter ***/
+
+int editorFilterWrite(int fd, int *j, int *off, int end) {	// write rows from E.row[*j] + *off, returns -1 when pipe is closed
+	struct iovec iov[EDITOR_IOV];
+	int n = 0;
+	int k = *j, o = *off;
+	while (k < end && n < EDITOR_IOV - 1) {	// every row is its chars and a \n, rows are not copied anywhere
+		if (o < E.row[k].size) {
+			iov[n].iov_base = &E.row[k].chars[o];
+			iov[n].iov_len = E.row[k].size - o;
+			n++;
+		}
+		iov[n].iov_base = "\n";
+		iov[n].iov_len = 1;
+		n++;
+		k++;
+		o = 0;
+	}
+	ssize_t written = writev(fd, iov, n);
+	if (written == -1)
+		return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+
+	while (written > 0) {			// move *j and *off ahead by no of bytes written
+		int left = E.row[*j].size - *off + 1;
+		if (written >= left) {
+			written -= left;
+			(*j)++;
+			*off = 0;
+		} else {
+			*off += written;
+			written = 0;
+		}
+	}
+	return 0;
+}
+
+void editorSpliceRows(int at, int n, erow *rows, int m) {	// replace n rows starting at at with m new rows
+	int j;
+	for (j = at; j < at + n; j++)
+		editorFreeRow(&E.row[j]);
+	if (m > n)
+		E.row = realloc(E.row, sizeof(erow) * (E.numrows - n + m));
+	memmove(&E.row[at + m], &E.row[at + n], sizeof(erow) * (E.numrows - at - n));	// rows after range are moved only once
+	memcpy(&E.row[at], rows, sizeof(erow) * m);
+	E.numrows += m - n;
+}
+
+void editorClosePipe(int p[2]) {
+	if (p[0] != -1) close(p[0]);
+	if (p[1] != -1) close(p[1]);
+}
+
+int editorFilterRows(int at, int n, char *cmd) {	// send n rows starting at at to cmd and replace them with its output
+	int in[2] = {-1, -1}, out[2] = {-1, -1}, err[2] = {-1, -1};
+	pid_t pid = -1;
+	if (pipe(in) == -1 || pipe(out) == -1 || pipe(err) == -1 || (pid = fork()) == -1) {
+		editorSetStatusMessage("Can't run filter: %s", strerror(errno));
+		editorClosePipe(in);
+		editorClosePipe(out);
+		editorClosePipe(err);
+		return -1;
+	}
+	if (pid == 0) {				// child, stdin, stdout and stderr are our pipes, so nothing is written on our screen
+		dup2(in[0], STDIN_FILENO);
+		dup2(out[1], STDOUT_FILENO);
+		dup2(err[1], STDERR_FILENO);
+		editorClosePipe(in);
+		editorClosePipe(out);
+		editorClosePipe(err);
+		execl("/bin/sh", "sh", "-c", cmd, (char *)NULL);
+		_exit(127);
+	}
+
+	close(in[0]);
+	close(out[1]);
+	close(err[1]);
+	fcntl(in[1], F_SETFL, O_NONBLOCK);
+	fcntl(out[0], F_SETFL, O_NONBLOCK);
+	fcntl(err[0], F_SETFL, O_NONBLOCK);
+
+	struct sigaction ign, old;		// if child exits without reading everything, write() should fail instead of killing us
+	memset(&ign, 0, sizeof(ign));
+	ign.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &ign, &old);
+
+	struct rowBuilder rb = {NULL, 0, 0, NULL, 0, 0};
+	char *buf = malloc(EDITOR_CHUNK);
+	int j = at, off = 0;
+	int wfd = in[1], rfd = out[0], efd = err[0];
+	int failed = 0;
+	char errline[128];			// first line of stderr, it is shown if command fails
+	int errlen = 0;
+	int errdone = 0;			// first line is complete
+	int sawerr = 0;				// command wrote something on stderr
+
+	if (n == 0) {
+		close(wfd);
+		wfd = -1;
+	}
+	while (rfd != -1 || efd != -1) {	// we write and read at same time, otherwise both of us can block on a full pipe
+		struct pollfd fds[3] = {
+			{ rfd, POLLIN, 0 },
+			{ wfd, POLLOUT, 0 },	// poll() ignores negative fd
+			{ efd, POLLIN, 0 }
+		};
+		if (poll(fds, 3, -1) == -1) {
+			if (errno == EINTR) continue;
+			failed = 1;
+			break;
+		}
+		if (fds[1].revents & (POLLOUT | POLLERR | POLLHUP)) {
+			if (editorFilterWrite(wfd, &j, &off, at + n) == -1 || j == at + n) {
+				close(wfd);	// EOF for child
+				wfd = -1;
+			}
+		}
+		if (fds[0].revents & (POLLIN | POLLERR | POLLHUP)) {
+			ssize_t nread = read(rfd, buf, EDITOR_CHUNK);
+			if (nread > 0) {
+				rbFeed(&rb, buf, nread);
+			} else if (nread == 0 || (errno != EAGAIN && errno != EINTR)) {
+				if (nread == -1) failed = 1;
+				close(rfd);
+				rfd = -1;
+			}
+		}
+		if (fds[2].revents & (POLLIN | POLLERR | POLLHUP)) {
+			ssize_t nread = read(efd, buf, EDITOR_CHUNK);
+			ssize_t k;
+			if (nread > 0) {
+				sawerr = 1;
+				for (k = 0; k < nread && !errdone; k++) {	// rest of stderr is read but not kept
+					if (buf[k] == '\n') errdone = 1;
+					else if (errlen < (int)sizeof(errline) - 1)
+						errline[errlen++] = ((unsigned char)buf[k] < 32) ? ' ' : buf[k];	// tabs and escape codes would mess up the screen
+				}
+			} else if (nread == 0 || (errno != EAGAIN && errno != EINTR)) {
+				close(efd);
+				efd = -1;
+			}
+		}
+	}
+	errline[errlen] = '\0';
+	if (wfd != -1) close(wfd);
+	if (rfd != -1) close(rfd);
+	if (efd != -1) close(efd);
+	free(buf);
+	sigaction(SIGPIPE, &old, NULL);
+
+	int status;
+	while (waitpid(pid, &status, 0) == -1 && errno == EINTR);
+	rbFinish(&rb);
+	int code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+	int ok = (code == 0) || (code == 1 && rb.numrows == 0 && !sawerr);	// grep gives 1 when no line matches, sed and cut give 1 with an error on stderr
+	if (failed || !ok) {			// failed command, keep rows as they are
+		if (failed)
+			editorSetStatusMessage("Filter failed, lines not changed");
+		else if (errlen > 0)
+			editorSetStatusMessage("Lines not changed: %s", errline);
+		else if (code == -1)
+			editorSetStatusMessage("Filter killed by signal %d, lines not changed", WTERMSIG(status));
+		else
+			editorSetStatusMessage("Filter exited with %d, lines not changed", code);
+		int k;
+		for (k = 0; k < rb.numrows; k++)
+			editorFreeRow(&rb.rows[k]);
+		free(rb.rows);
+		return -1;
+	}
+
+	editorSetStatusMessage("%d lines filtered into %d lines", n, rb.numrows);
+	editorSpliceRows(at, n, rb.rows, rb.numrows);
+	free(rb.rows);
+	return 0;
+}
+
+void editorFilter() {
+	editorLoadWait();			// rows at end of file may still be loading
+	char *buf = editorPrompt("Filter: ");	// "first,last command", or only "command" for whole file
+	if (buf == NULL) return;
+
+	int first, last, len = 0;
+	char *cmd = buf;
+	if (sscanf(buf, "%d,%d%n", &first, &last, &len) == 2) {
+		cmd = &buf[len];
+		while (*cmd == ' ') cmd++;
+	} else {
+		first = 1;
+		last = E.numrows;
+	}
+	if (first < 1) first = 1;
+
+	if (*cmd == '\0')			// nothing is run, tell user why
+		editorSetStatusMessage("Filter: no command given");
+	else if (last < first - 1)
+		editorSetStatusMessage("Filter: bad range %d,%d", first, last);
+	else if (first > E.numrows + 1)
+		editorSetStatusMessage("Filter: line %d is past end of file (%d lines)", first, E.numrows);
+	else {
+		if (last > E.numrows) last = E.numrows;
+		if (editorFilterRows(first - 1, last - first + 1, cmd) == 0) {
+			E.cy = first - 1;	// cursor at start of filtered range
+			E.cx = 0;
+			if (E.cy > E.numrows) E.cy = E.numrows;
+		}
+	}
+	free(buf);
+}
+
 /*** append buffer ***/
 struct abuf {
   char *b;
@@ -429,6 +1248,22 @@ void abFree(struct abuf *ab) {
   free(ab->b);
 }
 
+int abAppendCols(struct abuf *ab, const char *s, int len, int cols) {	// append whole utf-8 chars of s which fit in cols columns, returns columns used
+  int width = 0;
+  int j = 0;
+  while (j < len) {
+    uint32_t cp;
+    int n = utf8Decode(&s[j], len - j, &cp);
+    int w = utf8Width(cp);
+    if (width + w > cols) break;
+    if (cp == 0xFFFD && n == 1) abAppend(ab, "?", 1);	// invalid byte
+    else abAppend(ab, &s[j], n);
+    width += w;
+    j += n;
+  }
+  return width;
+}
+
 
 /**** output ****/
 
@@ -466,7 +1301,7 @@ void editorDrawRows(struct abuf *ab)
 		      char welcome[180], welcome1[180];
 		      int welcomelen = snprintf(welcome, sizeof(welcome),"Text Editor by: Hamza Zeb(1410) | Saud Ahmad(1393) | Sohail Khan(1497)\n");
 
-int welcomelen1 = snprintf(welcome1, sizeof(welcome1),"\n\rInstructions: Ctrl+Q->Exit | Ctrl+S->Save");
+int welcomelen1 = snprintf(welcome1, sizeof(welcome1),"\n\rInstructions: Ctrl+Q->Exit | Ctrl+S->Save | Ctrl+F->Filter");
 		      if (welcomelen > E.screencols) welcomelen = E.screencols;
 			if (welcomelen1 > E.screencols) welcomelen1 = E.screencols;
 	/*	      int padding = (E.screencols - welcomelen) / 2;
@@ -485,6 +1320,27 @@ int welcomelen1 = snprintf(welcome1, sizeof(welcome1),"\n\rInstructions: Ctrl+Q-
 		      abAppend(ab, "~", 1);
 		}
 	   }
+	   else if (!E.row[filerow].ascii) {		// utf-8 row, E.coloff and E.screencols are columns not bytes
+      			erow *row = &E.row[filerow];
+      			int col = 0, j = 0;
+      			uint32_t cp;
+      			while (j < row->rsize && col < E.coloff) {	// skip chars left of the screen
+      				j += utf8Decode(&row->render[j], row->rsize - j, &cp);
+      				col += utf8Width(cp);
+      			}
+      			int width = col - E.coloff;		// a wide char cut by left edge of screen, draw blank instead of it
+      			if (width > E.screencols) width = E.screencols;
+      			abAppend(ab, "  ", width);
+      			int start = j;
+      			while (j < row->rsize) {
+      				int n = utf8Decode(&row->render[j], row->rsize - j, &cp);
+      				int w = utf8Width(cp);
+      				if (width + w > E.screencols) break;	// this will truncate
+      				width += w;
+      				j += n;
+      			}
+      			abAppend(ab, &row->render[start], j - start);
+	   }
 	   else {			// this else will write rows at terminal
       			int len = E.row[filerow].rsize - E.coloff;	// E.row[filerow].size = row size, E.coloff = current cursor position in row ( 30 char - 0 coloff=30, 30 char - 32 coloff=-2)
       			if (len < 0) len = 0;				// if cursor is move ahead of num of chars in row then len = 0
@@ -493,11 +1349,28 @@ int welcomelen1 = snprintf(welcome1, sizeof(welcome1),"\n\rInstructions: Ctrl+Q-
     		}
 	//	abAppend(ab, "~", 1);	// will draw ~ at start of each row
 		abAppend(ab, "\x1b[K", 3); // K means clear current line, by default it has 0 which means erase from active position to the end of line. It replace [2J	    	
-		if (y < E.screenrows - 1) 	// will prevent to enter a new line at last.
-		{	
-      			abAppend(ab, "\r\n", 2);;	
+      		abAppend(ab, "\r\n", 2);	// last line of screen is for status message
+	}
+}
+
+int editorDrawMessageBar(struct abuf *ab) {	// returns column after the text, cursor goes there while prompting
+	abAppend(ab, "\x1b[K", 3);
+	if (E.prompt) {
+		int avail = E.screencols - 1;		// keep one column for cursor
+		int width = abAppendCols(ab, E.prompt, strlen(E.prompt), avail);
+		int len = strlen(E.promptbuf);
+		int textwidth = utf8StrWidth(E.promptbuf, len);
+		int j = 0;
+		while (j < len && width + textwidth > avail) {	// text is too long, show its end where user is typing
+			uint32_t cp;
+			j += utf8Decode(&E.promptbuf[j], len - j, &cp);
+			textwidth -= utf8Width(cp);
 		}
+		return width + abAppendCols(ab, &E.promptbuf[j], len - j, avail - width);
 	}
+	if (E.statusmsg[0] && time(NULL) - E.statusmsg_time < 5)	// message is shown for 5 seconds
+		abAppendCols(ab, E.statusmsg, strlen(E.statusmsg), E.screencols);
+	return 0;
 }
 
 void editorRefreshScreen()
@@ -512,9 +1385,13 @@ void editorRefreshScreen()
   	abAppend(&ab, "\x1b[H", 3);	// reposition our cursor to top left
 
 	editorDrawRows(&ab);		// will draw teldas and welcome message
+	int msgcol = editorDrawMessageBar(&ab);
   	
 	char buf[32];
-	snprintf(buf, sizeof(buf), "\x1b[%d;%dH", (E.cy - E.rowoff) + 1, (E.rx - E.coloff) + 1);	// reposition our cursor to these locations
+	if (E.prompt)
+		snprintf(buf, sizeof(buf), "\x1b[%d;%dH", E.screenrows + 1, msgcol + 1);	// cursor after typed text of prompt
+	else
+		snprintf(buf, sizeof(buf), "\x1b[%d;%dH", (E.cy - E.rowoff) + 1, (E.rx - E.coloff) + 1);	// reposition our cursor to these locations
 	abAppend(&ab, buf, strlen(buf));
 
   	abAppend(&ab, "\x1b[?25h", 6);	//SM(set mode) display cursor to prevent annoying flicker effect
@@ -525,24 +1402,49 @@ void editorRefreshScreen()
 	//write(STDOUT_FILENO, "\x1b[H", 3);	// reposition our cursor to top left
 }
 
+void editorSetStatusMessage(const char *fmt, ...) {	// same as printf(), message is shown at bottom of screen
+	va_list ap;
+	va_start(ap, fmt);
+	int len = vsnprintf(E.statusmsg, sizeof(E.statusmsg), fmt, ap);
+	va_end(ap);
+	if (len >= (int)sizeof(E.statusmsg)) {	// message was cut, don't leave half of a utf-8 char at end
+		len = sizeof(E.statusmsg) - 1;
+		int j = len;
+		while (j > 0 && len - j < 3 && UTF8_IS_CONT(E.statusmsg[j - 1])) j--;
+		if (j > 0 && utf8SeqLen[(unsigned char)E.statusmsg[j - 1] >> 4] != len - j + 1)	// last char is not complete
+			E.statusmsg[j - 1] = '\0';
+	}
+	E.statusmsg_time = time(NULL);
+}
+
 /**** input ****/
 
-char *editorPrompt(char *prompt) {
+char *editorPrompt(char *prompt) {	// prompt is shown in last line of screen followed by typed text
   size_t bufsize = 128;
   char *buf = malloc(bufsize);
   size_t buflen = 0;
   buf[0] = '\0';
+  E.prompt = prompt;
   while (1) {
+    E.promptbuf = buf;
     editorRefreshScreen();
     int c = editorReadKey();
     if (c == '\x1b') {
+      E.prompt = NULL;
       free(buf);
       return NULL;
     } else if (c == '\r') {
       if (buflen != 0) {
+        E.prompt = NULL;
         return buf;
       }
-    } else if (!iscntrl(c) && c < 128) {
+    } else if (c == BACKSPACE || c == CTRL_KEY('h') || c == DEL_KEY) {
+      if (buflen != 0) {
+        do buflen--;			// remove whole utf-8 char
+        while (buflen > 0 && UTF8_IS_CONT(buf[buflen]));
+        buf[buflen] = '\0';
+      }
+    } else if (c < 256 && !iscntrl(c)) {	// c >= 128 are utf-8 bytes, keys like ARROW_UP are >= 1000
       if (buflen == bufsize - 1) {
         bufsize *= 2;
         buf = realloc(buf, bufsize);
@@ -555,11 +1457,12 @@ char *editorPrompt(char *prompt) {
 
 void editorMoveCursor(int key) {
 	  erow *row = (E.cy >= E.numrows) ? NULL : &E.row[E.cy];	// here we use the ternary operator to check if the cursor is on an actual line. If it is, then the row variable will point to the erow that the cursor is on.
+	  int rx = row ? editorRowCxToRx(row, E.cx) : 0;		// column on screen, up and down keep this column not the byte index E.cx
 
 	switch (key) {
 		    case ARROW_LEFT:
       			if (E.cx != 0) {			// prevent moving cursor out of the screen
-        			E.cx--;			// x-axis, move accross x-axis(horizontal)
+        			E.cx = editorRowPrevCx(row, E.cx);	// x-axis, move accross x-axis(horizontal), whole utf-8 char at once
       			} else if (E.cy > 0) 
 			  {
         			E.cy--;
@@ -568,8 +1471,8 @@ void editorMoveCursor(int key) {
       			break;
     		case ARROW_RIGHT:
       			if (row && E.cx < row->size) {		// here it will check if no of chars == E.cx then our cursor will no furthur move towards right, it will stick after the last char in a line.
-        			E.cx++;
-      			} else if (row && E.cx == row->size) 
+        			E.cx = editorRowNextCx(row, E.cx);
+      			} else if (row && E.cx == row->size && E.cy < editorLastCy()) 
 			  {
         			E.cy++;
         			E.cx = 0;			// we are setting E.cx to the start of row
@@ -578,11 +1481,13 @@ void editorMoveCursor(int key) {
     		case ARROW_UP:
       			if (E.cy != 0) {			// prevent moving cursor out of the screen
         			E.cy--;			// y-axis, move accross y-axis(verticle)
+        			E.cx = editorRowRxToCx(&E.row[E.cy], rx);
       			}
       			break;
     		case ARROW_DOWN:
-      			if (E.cy < E.numrows) {		// prevent moving cursor out of the bottom of file
+      			if (E.cy < editorLastCy()) {		// prevent moving cursor out of the bottom of file
         			E.cy++;
+        			E.cx = (E.cy < E.numrows) ? editorRowRxToCx(&E.row[E.cy], rx) : 0;
       			}
 	      		break;
 	}
@@ -615,6 +1520,10 @@ void editorProcessKeypress()
       			editorSave();
       			break;    		
 
+		case CTRL_KEY('f'):
+			editorFilter();
+			break;
+
 		case HOME_KEY:
 			E.cx = 0;			// move at start of line
 			break;
@@ -627,7 +1536,10 @@ void editorProcessKeypress()
 		case BACKSPACE:
 		case CTRL_KEY('h'): // this will sends the control code 8, which is originally what the Backspace character would send back in the day
     		case DEL_KEY:
-      			if (c == DEL_KEY) editorMoveCursor(ARROW_RIGHT);	// if we press del key then it will move to next char and del that char other wise if we press backspace then it will simply replace previous car with next one.
+      			if (c == DEL_KEY) {	// if we press del key then it will move to next char and del that char other wise if we press backspace then it will simply replace previous car with next one.
+      				editorLoadWaitAtEnd();	// del at end of last loaded row joins it with next row, which may not be loaded yet
+      				editorMoveCursor(ARROW_RIGHT);
+      			}
       			editorDelChar();
       			break;
 
@@ -638,7 +1550,7 @@ void editorProcessKeypress()
           				E.cy = E.rowoff;	// position cursor to top of screen
         			} else if (c == PAGE_DOWN) {
           				E.cy = E.rowoff + E.screenrows - 1; // position cursor to bottom of second screen if total rows of file is equal to 30 and screenrows are 20 then rowoff will be 10.
-          				if (E.cy > E.numrows) E.cy = E.numrows;
+          				if (E.cy > editorLastCy()) E.cy = editorLastCy();
         			  }        			
 				int times = E.screenrows;		// will move at top or bottom
         			while (times--)				// run upto windowsize->rows times
@@ -676,9 +1588,21 @@ void initEditor()
 	E.numrows = 0;		// by default set number of rows = 0
 	E.row = NULL;		// initially put NULL in E.row pointer, we use this for storing multiple rows
 	E.filename = NULL;
+	E.compress = COMPRESS_NONE;
+	E.statusmsg[0] = '\0';
+	E.statusmsg_time = 0;
+	E.prompt = NULL;
+	E.promptbuf = NULL;
+
+	L.active = 0;		// no file is being loaded in background
+	L.rows = NULL;
+	L.numrows = 0;
+	pthread_mutex_init(&L.lock, NULL);
+	pthread_cond_init(&L.ready, NULL);
 
 	if (getWindowSize(&E.screenrows, &E.screencols) == -1 )
 		die("Error in getWindowSize");
+	E.screenrows -= 1;	// for status message
 }
 	
 int main(int argc, char *argv[])